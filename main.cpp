@@ -1,10 +1,13 @@
 #include "philox_engine.hpp"
+#include "philox_stream_broker.hpp"
 #include "subtract_with_carry_engine.hpp"
 
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <limits>
 #include <random>
+#include <stdexcept>
 
 // #include <iostream>
 
@@ -31,6 +34,37 @@ constexpr auto period(RNG const & /* rng */) -> unsigned long long {
   return detail::pow<r>(w) - detail::pow<s>(w);
 }
 
+// hands fixed 32 bit words to the SeedSeq constructor, so that keys can be set
+// directly: philox takes them lowest key word first, low half first
+template <std::size_t N> struct fixed_seed_seq {
+  std::array<std::uint32_t, N> words;
+
+  template <class Iter> void generate(Iter first, Iter last) const {
+    auto iter = this->words.begin();
+    for (; first != last; ++first) {
+      *first = *iter++;
+    }
+  }
+};
+
+// first block of the fixed version for a given key and counter
+template <class Philox, std::size_t N>
+auto known_answer(
+    std::array<std::uint32_t, N> const &key,
+    std::array<typename Philox::result_type, Philox::word_count> const &counter,
+    std::array<typename Philox::result_type, Philox::word_count> const
+        &expected) -> bool {
+  fixed_seed_seq<N> seq{key};
+  Philox rng(seq);
+  rng.set_counter(counter);
+  for (auto const value : expected) {
+    if (rng.template operator()<true>() != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // as defined in https://en.wikipedia.org/wiki/Linear_congruential_generator
 template <class UIntType>
 using randq1 =
@@ -137,6 +171,149 @@ int main() {
       assert(rng1_fix() == 1955073260U);
       assert(rng2_fix() == 3409172418970261260U);
     }
+
+    // known answers of Random123 (kat_vectors), reproduced by the fixed
+    // version only. Checked through result so they also run in Release builds.
+    // Counter and key 0 alone would hide a key or multiplier ordering mistake,
+    // so every preset is also checked with the digits of pi as in Random123.
+    {
+      using p4x32 = stdmock::philox4x32;
+      using p4x32_7 = stdmock::philox4x32_7;
+      using p4x64 = stdmock::philox4x64;
+      using p4x64_7 = stdmock::philox4x64_7;
+      using p2x64 = stdmock::philox2x64;
+
+      // counters are given most significant word first, as in set_counter
+      constexpr std::array<std::uint32_t, 2> pi_key32{0xa4093822, 0x299f31d0};
+      constexpr std::array<std::uint32_t, 4> pi_key64{0x38d01377, 0x452821e6,
+                                                      0x34e90c6c, 0xbe5466cf};
+      constexpr std::array<std::uint32_t, 2> pi_key2x64{0x299f31d0,
+                                                        0xa4093822};
+      constexpr std::array<std::uint32_t, 2> ones_key32{0xffffffff,
+                                                        0xffffffff};
+      constexpr std::array<std::uint32_t, 2> zero_key2{};
+      constexpr std::array<std::uint32_t, 4> zero_key4{};
+
+      if (!known_answer<p4x32>(zero_key2, {},
+                               {0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                0x9b00dbd8}) ||
+          !known_answer<p4x32>(
+              pi_key32, {0x03707344, 0x13198a2e, 0x85a308d3, 0x243f6a88},
+              {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}) ||
+          !known_answer<p4x32>(
+              ones_key32, {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+              {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd})) {
+        result = 1;
+      }
+
+      if (!known_answer<p4x32_7>(zero_key2, {},
+                                 {0x5f6fb709, 0x0d893f64, 0x4f121f81,
+                                  0x4f730a48}) ||
+          !known_answer<p4x32_7>(
+              pi_key32, {0x03707344, 0x13198a2e, 0x85a308d3, 0x243f6a88},
+              {0x4dfccaba, 0x190a87f0, 0xc47362ba, 0xb6b5242a})) {
+        result = 1;
+      }
+
+      if (!known_answer<p4x64>(
+              pi_key64,
+              {0x082efa98ec4e6c89, 0xa4093822299f31d0, 0x13198a2e03707344,
+               0x243f6a8885a308d3},
+              {0xa528f45403e61d95, 0x38c72dbd566e9788, 0xa5a1610e72fd18b5,
+               0x57bd43b5e52b7fe6})) {
+        result = 1;
+      }
+
+      if (!known_answer<p4x64_7>(zero_key4, {},
+                                 {0x5dc8ee6268ec62cd, 0x139bc570b6c125a0,
+                                  0x84d6deb4fb65f49e, 0xaff7583376d378c2}) ||
+          !known_answer<p4x64_7>(
+              pi_key64,
+              {0x082efa98ec4e6c89, 0xa4093822299f31d0, 0x13198a2e03707344,
+               0x243f6a8885a308d3},
+              {0x513a366704edf755, 0xf05d9924c07044d3, 0xbef2cb9cbea74c6c,
+               0x8db948de4caa1f8a})) {
+        result = 1;
+      }
+
+      if (!known_answer<p2x64>(zero_key2, {},
+                               {0xca00a0459843d731, 0x66c24222c9a845b5}) ||
+          !known_answer<p2x64>(pi_key2x64,
+                               {0x13198a2e03707344, 0x243f6a8885a308d3},
+                               {0x0a5e742c2997341c, 0xb0f883d38000de5d})) {
+        result = 1;
+      }
+    }
+
+    // substreams handed out by the broker
+    {
+      // set_counter takes the most significant word first
+      stdmock::philox4x32 rng1;
+      stdmock::philox4x32 rng2;
+      rng1.set_counter({0, 0, 0, 1});
+      rng2.discard(4);
+      // the buffered Y still differs until the next block is generated
+      if (rng1() != rng2() || !(rng1 == rng2)) {
+        result = 1;
+      }
+
+      stdmock::stream_broker<stdmock::philox4x64> broker;
+      stdmock::philox4x64 rng3;
+      auto s0 = broker.lease();
+      auto s1 = broker.lease();
+      if (broker.leased() != 2 || !(s0 == rng3) || s0() == s1()) {
+        result = 1;
+      }
+
+      // keyed streams do not depend on the order they are requested in
+      auto t7 = broker.stream(7);
+      auto t3 = broker.stream(3);
+      if (!(t7 == broker.stream(7)) || !(t3 == broker.stream(3)) ||
+          t7.operator()<true>() == t3.operator()<true>()) {
+        result = 1;
+      }
+
+      // 64 bit ids span the two top counter words of philox4x32
+      stdmock::stream_broker<stdmock::philox4x32> broker32;
+      if (broker32.stream(1ULL << 32U) == broker32.stream(0) ||
+          broker32.stream(1ULL << 32U) == broker32.stream(1)) {
+        result = 1;
+      }
+
+      // with a single id word, ids past 2^w are refused rather than wrapped
+      using philox2x32 = stdmock::philox_engine<std::uint_fast32_t, 32, 2, 10,
+                                                0xD256D193, 0x9E3779B9>;
+      stdmock::stream_broker<philox2x32> broker2x32;
+      bool refused = false;
+      try {
+        broker2x32.stream(1ULL << 32U);
+      } catch (std::out_of_range const &) {
+        refused = true;
+      }
+      if (!refused) {
+        result = 1;
+      }
+
+      // an exhausted lease() throws without using up an id. 8 bit words leave
+      // 256 streams.
+      using philox2x8 =
+          stdmock::philox_engine<std::uint_fast16_t, 8, 2, 10, 0xD2, 0x9E>;
+      stdmock::stream_broker<philox2x8> broker2x8;
+      for (unsigned int id = 0; id <= broker2x8.max_stream; ++id) {
+        broker2x8.lease();
+      }
+      for (int attempt = 0; attempt < 2; ++attempt) {
+        bool exhausted = false;
+        try {
+          broker2x8.lease();
+        } catch (std::out_of_range const &) {
+          exhausted = true;
+        }
+        if (!exhausted || broker2x8.leased() != broker2x8.max_stream + 1) {
+          result = 1;
+        }
+      }
+    }
   }
 
   return result;
@@ -1,6 +1,7 @@
 #ifndef PHILOX_ENGINE
 #define PHILOX_ENGINE
 
+#include "rng_stats.hpp"
 #include "uint128.hpp"
 
 #include <array>
@@ -18,11 +19,22 @@ private:
   static_assert(0 < r);
   static_assert(0 < w && w <= std::numeric_limits<UIntType>::digits);
 
+  // when w fills UIntType, arithmetic already wraps modulo 2^w
+  static constexpr bool full_width =
+      (w == std::numeric_limits<UIntType>::digits);
+
+  static constexpr auto mod_w(UIntType value) -> UIntType {
+    if constexpr (full_width) {
+      return value;
+    } else {
+      return value & max();
+    }
+  }
+
   inline void increase_counter() {
-    constexpr auto in_mask = max();
     std::size_t i = 0;
     do {
-      this->X[i] = (this->X[i] + 1) & in_mask;
+      this->X[i] = mod_w(this->X[i] + 1);
       ++i;
     } while (i < n && !this->X[i - 1]);
   }
@@ -31,7 +43,7 @@ private:
     constexpr auto in_mask = max();
     std::size_t i = 0;
     do {
-      this->X[i] = (this->X[i] - 1) & in_mask;
+      this->X[i] = mod_w(this->X[i] - 1);
       ++i;
     } while (i < n && (this->X[i - 1] == in_mask));
   }
@@ -54,10 +66,7 @@ public:
 
   philox_engine() : philox_engine(default_seed) {}
 
-  explicit philox_engine(result_type value) {
-    constexpr result_type mask = max();
-    this->K[0] = value & mask;
-  }
+  explicit philox_engine(result_type value) { this->K[0] = mod_w(value); }
 
   template <class SeedSeq> explicit philox_engine(SeedSeq &seq) {
     constexpr std::size_t p = (w - 1) / 32 + 1;
@@ -66,28 +75,39 @@ public:
     std::array<std::uint_least32_t, n_half * p> a;
     seq.generate(a.begin(), a.end());
 
-    constexpr result_type mask = max();
     auto iter = a.begin();
     for (std::size_t n_idx = 0; n_idx < n_half; n_idx++) {
       UIntType val = 0;
       for (std::size_t p_idx = 0; p_idx < p; ++p_idx) {
         val += static_cast<UIntType>(*iter++) << 32 * p_idx;
       }
-      this->K[n_idx] = val & mask;
+      this->K[n_idx] = mod_w(val);
     }
   }
 
   template <std::size_t Version = 1> inline auto operator()() -> result_type {
     ++this->j;
     if (this->j == n) {
+      RNG_STATS_ADD(philox_blocks, 1);
       this->generate<Version>();
       this->increase_counter();
       this->j = 0;
+    } else {
+      RNG_STATS_ADD(philox_buffered, 1);
     }
     return Y[this->j];
   }
 
+  // as in P2075: X_j = c_{n - 1 - j} mod 2^w, next call generates a new block
+  void set_counter(std::array<result_type, n> const &c) {
+    for (std::size_t idx = 0; idx < n; ++idx) {
+      this->X[idx] = mod_w(c[n - 1 - idx]);
+    }
+    this->j = n - 1;
+  }
+
   template <bool Fix = false> inline void discard(unsigned long long z) {
+    RNG_STATS_ADD(philox_discard_draws, z);
     for (unsigned long long i = 0; i < z; ++i) {
       this->operator()<Fix>();
     }
@@ -110,11 +130,10 @@ private:
 
     const upgraded_type ab =
         static_cast<upgraded_type>(a) * static_cast<upgraded_type>(b);
-    return {static_cast<U>(ab >> w), static_cast<U>(ab) & this->max()};
+    return {static_cast<U>(ab >> w), mod_w(static_cast<U>(ab))};
   }
 
   template <bool Fix> inline void generate() {
-    constexpr auto in_mask = max();
     constexpr std::array<UIntType, n> consts_arr{consts...};
     if constexpr (n == 2) {
 
@@ -127,7 +146,7 @@ private:
           auto [hi, lo] = this->mulhilo(S1, consts_arr[0]);
           S0 = lo;
           S1 = hi ^ K0 ^ S0;
-          K0 = (K0 + consts_arr[1]) & in_mask;
+          K0 = mod_w(K0 + consts_arr[1]);
         }
         this->Y[0] = S0;
         this->Y[1] = S1;
@@ -140,7 +159,7 @@ private:
           auto [hi, lo] = this->mulhilo(S0, consts_arr[0]);
           S0 = hi ^ K0 ^ S1;
           S1 = lo;
-          K0 = (K0 + consts_arr[1]) & in_mask;
+          K0 = mod_w(K0 + consts_arr[1]);
         }
         this->Y[0] = S0;
         this->Y[1] = S1;
@@ -182,8 +201,8 @@ private:
           // V_{2.k} for k = 1
           S3 = hi3 ^ K1 ^ V2;
 
-          K0 = (K0 + consts_arr[1]) & in_mask;
-          K1 = (K1 + consts_arr[3]) & in_mask;
+          K0 = mod_w(K0 + consts_arr[1]);
+          K1 = mod_w(K1 + consts_arr[3]);
         }
 
         // "3. Replaces the values in the buffer Y with the values in S."
@@ -227,8 +246,8 @@ private:
           // X_{2.k+1}=mullo(V_{2.k},M_k,w) for k = 1
           S3 = lo2;
 
-          K0 = (K0 + consts_arr[1]) & in_mask;
-          K1 = (K1 + consts_arr[3]) & in_mask;
+          K0 = mod_w(K0 + consts_arr[1]);
+          K1 = mod_w(K1 + consts_arr[3]);
         }
 
         // "3. Replaces the values in the buffer Y with the values in S."
@@ -253,6 +272,19 @@ using philox4x64 =
     philox_engine<std::uint_fast64_t, 64, 4, 10, 0xD2E7470EE14C6C93,
                   0x9E3779B97F4A7C15, 0xCA5A826395121157, 0xBB67AE8584CAA73B>;
 
+// reduced round variants, as in Random123. They pass BigCrush with a smaller
+// safety margin than the 10 round engines above (Salmon et al., table 2).
+using philox4x32_7 = philox_engine<std::uint_fast32_t, 32, 4, 7, 0xD2511F53,
+                                   0x9E3779B9, 0xCD9E8D57, 0xBB67AE85>;
+
+using philox4x64_7 =
+    philox_engine<std::uint_fast64_t, 64, 4, 7, 0xD2E7470EE14C6C93,
+                  0x9E3779B97F4A7C15, 0xCA5A826395121157, 0xBB67AE8584CAA73B>;
+
+// Philox-2x64 from the original paper, only meaningful with the Fix version
+using philox2x64 = philox_engine<std::uint_fast64_t, 64, 2, 10,
+                                 0xD2B74407B1CE6E93, 0x9E3779B97F4A7C15>;
+
 } // namespace stdmock
 
 #endif // PHILOX_ENGINE
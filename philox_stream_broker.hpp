@@ -0,0 +1,98 @@
+#ifndef PHILOX_STREAM_BROKER
+#define PHILOX_STREAM_BROKER
+
+#include "philox_engine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace stdmock {
+
+// Hands out independent substreams of a single philox key to many threads.
+//
+// Stream i is the engine positioned at the counter whose most significant
+// words hold i, so it owns every block below the next stream and streams never
+// overlap. Stream 0 is the engine the broker was seeded with. The id spans the
+// top ceil(64 / w) counter words, keeping at least one word for the blocks: a
+// philox4x32 stream has 2^64 blocks, a philox4x64 stream 2^192.
+//
+// lease() takes the next free stream with a relaxed compare-and-swap loop,
+// which is the only shared write. stream(id) needs no shared state at all: keying it by
+// task id gives results that do not depend on scheduling. Both return a plain
+// engine by value, so drawing from it never touches the broker again. The two
+// share the same id space, so a broker should use one or the other.
+//
+// When fewer than 64 bits are available for the id (n == 2 with w < 64), ids
+// above max_stream throw std::out_of_range instead of wrapping onto earlier
+// streams, and so does lease() once every stream has been handed out.
+template <class PhiloxEngine> class stream_broker {
+public:
+  using engine_type = PhiloxEngine;
+  using result_type = typename PhiloxEngine::result_type;
+  using stream_id = std::uint64_t;
+
+private:
+  static constexpr std::size_t w = engine_type::word_size;
+  static constexpr std::size_t id_words =
+      std::min<std::size_t>((64 + w - 1) / w, engine_type::word_count - 1);
+
+public:
+  static constexpr stream_id max_stream =
+      (id_words * w >= 64) ? ~stream_id(0)
+                           : (stream_id(1) << (id_words * w)) - 1U;
+
+  stream_broker() : stream_broker(PhiloxEngine::default_seed) {}
+
+  explicit stream_broker(result_type value) : base(value) {}
+
+  template <class SeedSeq> explicit stream_broker(SeedSeq &seq) : base(seq) {}
+
+  stream_broker(const stream_broker &) = delete;
+  auto operator=(const stream_broker &) -> stream_broker & = delete;
+
+  // the next stream that has not been leased yet. Throws std::out_of_range
+  // once max_stream has been leased, without consuming an id, so leased()
+  // never exceeds max_stream + 1.
+  inline auto lease() -> engine_type {
+    stream_id id = this->next.load(std::memory_order_relaxed);
+    do {
+      // with 64 id bits the last id is kept back so that next cannot wrap
+      if (id > max_stream || id == ~stream_id(0)) {
+        throw std::out_of_range("stream_broker: no stream left to lease");
+      }
+    } while (!this->next.compare_exchange_weak(id, id + 1,
+                                               std::memory_order_relaxed));
+    return this->stream(id);
+  }
+
+  // deterministic assignment, e.g. keyed by task id. Does not consume leases.
+  inline auto stream(stream_id id) const -> engine_type {
+    if (id > max_stream) {
+      throw std::out_of_range("stream_broker: stream id out of range");
+    }
+    std::array<result_type, engine_type::word_count> c{};
+    for (std::size_t k = 0; k < id_words; ++k) {
+      c[id_words - 1 - k] =
+          static_cast<result_type>((id >> (w * k)) & engine_type::max());
+    }
+    engine_type e = this->base;
+    e.set_counter(c);
+    return e;
+  }
+
+  auto leased() const -> stream_id {
+    return this->next.load(std::memory_order_relaxed);
+  }
+
+private:
+  const engine_type base;
+  // kept off the cache line of base, which every stream() call reads
+  alignas(64) std::atomic<stream_id> next{0};
+};
+
+} // namespace stdmock
+
+#endif // PHILOX_STREAM_BROKER
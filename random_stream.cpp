@@ -0,0 +1,522 @@
+#include "philox_engine.hpp"
+#include "subtract_with_carry_engine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Streams the raw output of an engine to stdout (or a file) so it can be piped
+// into external statistical batteries such as PractRand or TestU01:
+//
+//   random_stream philox4x64_fix | RNG_test stdin64
+//   random_stream --engine ranlux24_base_fix --bytes 1T --threads 4 -o out.bin
+//
+// Words are w bits wide, so they are packed LSB first into a contiguous bit
+// stream: no padding bits are emitted when w is not a multiple of 8.
+//
+// --draws N prints the first N draws of the engine as decimal text instead,
+// as a reference for the packed stream.
+//
+// Throughput is reported on stderr every --report-every seconds (60 by
+// default) and once more at the end, also when the run is stopped by SIGINT
+// or SIGTERM.
+//
+// With --threads T, producer k fills blocks k, k + T, k + 2T, ... and blocks
+// are written in order, so the output never depends on scheduling. Counter
+// based engines (philox) jump to the first draw of each block with
+// set_counter, so their output is the engine's own stream for every T and
+// block size: a failure found with --threads 8 reproduces single threaded.
+// The subtract with carry engines cannot jump ahead, so there producer k owns
+// an engine seeded with seed + k and the output depends on T and the block
+// size.
+
+namespace {
+
+constexpr std::size_t page_size = 4096;
+constexpr std::size_t slots_per_producer = 2;
+
+// set from the signal handler, lets an interrupted run still report
+std::atomic<bool> interrupted{false};
+static_assert(std::atomic<bool>::is_always_lock_free);
+
+extern "C" void on_interrupt(int /* signal */) { interrupted.store(true); }
+
+struct aligned_delete {
+  void operator()(unsigned char *p) const {
+    ::operator delete(p, std::align_val_t{page_size});
+  }
+};
+
+using aligned_buffer = std::unique_ptr<unsigned char[], aligned_delete>;
+
+auto make_aligned_buffer(std::size_t bytes) -> aligned_buffer {
+  return aligned_buffer(static_cast<unsigned char *>(
+      ::operator new(bytes, std::align_val_t{page_size})));
+}
+
+struct options {
+  std::string engine;
+  std::string output;
+  unsigned long long bytes = 0; // 0 means stream until the reader goes away
+  unsigned long long seed = 0;
+  bool seed_set = false;
+  std::size_t threads = 1;
+  std::size_t block_bytes = std::size_t(1) << 22;
+  unsigned long long report_seconds = 60; // 0 only reports at the end
+  unsigned long long draws = 0; // non zero prints that many draws as text
+};
+
+// engines that can be positioned at any block of their stream
+template <class RNG>
+concept counter_based =
+    requires(RNG &rng,
+             std::array<typename RNG::result_type, RNG::word_count> const &c) {
+      rng.set_counter(c);
+    };
+
+// positions rng so that its next draw is draw number `draw_index`, which is a
+// multiple of the word count
+template <counter_based RNG>
+void seek(RNG &rng, unsigned long long draw_index) {
+  constexpr std::size_t n = RNG::word_count;
+  constexpr std::size_t w = RNG::word_size;
+  unsigned long long block = draw_index / n;
+  std::array<typename RNG::result_type, n> c{};
+  for (std::size_t idx = 0; idx < n && block != 0; ++idx) {
+    c[n - 1 - idx] = static_cast<typename RNG::result_type>(block & RNG::max());
+    block = (w >= 64) ? 0 : (block >> (w % 64));
+  }
+  rng.set_counter(c);
+}
+
+// fills the packed bit stream of `words` draws. `words` is a multiple of 16 so
+// every block ends on a byte boundary, can be concatenated, and starts a new
+// philox block for every word count.
+template <std::size_t w, class RNG, class Draw>
+auto fill_block(RNG &rng, Draw draw, unsigned char *out, std::size_t words)
+    -> std::size_t {
+  unsigned char *const begin = out;
+  if constexpr (w % 8 == 0 && std::endian::native == std::endian::little) {
+    // the low w / 8 bytes of a little endian word are its packed form, so
+    // each draw is a single fixed size store
+    for (std::size_t idx = 0; idx < words; ++idx) {
+      const auto v = draw(rng);
+      std::memcpy(out, &v, w / 8);
+      out += w / 8;
+    }
+  } else if constexpr (w % 8 == 0) {
+    for (std::size_t idx = 0; idx < words; ++idx) {
+      auto v = draw(rng);
+      for (std::size_t b = 0; b < w / 8; ++b) {
+        *out++ = static_cast<unsigned char>(v);
+        v >>= (w > 8) ? 8 : 0;
+      }
+    }
+  } else {
+    std::uint64_t acc = 0;
+    std::size_t bits = 0;
+    for (std::size_t idx = 0; idx < words; ++idx) {
+      std::uint64_t v = static_cast<std::uint64_t>(draw(rng));
+      std::size_t left = w;
+      while (left > 0) {
+        const std::size_t take = std::min(left, std::size_t(64) - bits);
+        const std::uint64_t part =
+            (take == 64) ? v : (v & ((std::uint64_t(1) << take) - 1U));
+        acc |= part << bits;
+        bits += take;
+        left -= take;
+        v = (take == 64) ? 0 : (v >> take);
+        while (bits >= 8) {
+          *out++ = static_cast<unsigned char>(acc);
+          acc >>= 8;
+          bits -= 8;
+        }
+      }
+    }
+  }
+  return static_cast<std::size_t>(out - begin);
+}
+
+struct slot {
+  aligned_buffer data;
+  std::size_t size = 0;
+  std::atomic<bool> full{false};
+};
+
+auto write_all(std::FILE *file, unsigned char const *data, std::size_t size)
+    -> bool {
+  return std::fwrite(data, 1, size, file) == size;
+}
+
+void report(options const &opt, char const *when, unsigned long long written,
+            double seconds) {
+  std::fprintf(stderr,
+               "random_stream: %s, %zu thread(s), %s: %llu bytes in %.3f s, "
+               "%.3f GB/s\n",
+               opt.engine.c_str(), opt.threads, when, written, seconds,
+               seconds > 0.0 ? static_cast<double>(written) / seconds / 1e9
+                             : 0.0);
+}
+
+template <class RNG, std::size_t w, class Draw>
+auto run(options const &opt, std::FILE *file) -> int {
+  static_assert(w <= 64);
+  const std::size_t block_bytes =
+      (opt.bytes != 0 && opt.bytes < opt.block_bytes)
+          ? static_cast<std::size_t>(opt.bytes)
+          : opt.block_bytes;
+  const std::size_t words =
+      std::max<std::size_t>(16, (block_bytes * 8 / w) / 16 * 16);
+  const std::size_t block_capacity = words * w / 8;
+
+  using seed_type = typename RNG::result_type;
+  const unsigned long long seed =
+      opt.seed_set ? opt.seed
+                   : static_cast<unsigned long long>(RNG::default_seed);
+
+  // reference output for checking the packed stream, one decimal per line
+  if (opt.draws != 0) {
+    RNG rng(static_cast<seed_type>(seed));
+    for (unsigned long long idx = 0; idx < opt.draws; ++idx) {
+      std::fprintf(file, "%llu\n",
+                   static_cast<unsigned long long>(Draw{}(rng)));
+    }
+    return std::ferror(file) ? 1 : 0;
+  }
+
+  std::vector<RNG> engines;
+  engines.reserve(opt.threads);
+  for (std::size_t k = 0; k < opt.threads; ++k) {
+    if constexpr (counter_based<RNG>) {
+      engines.emplace_back(static_cast<seed_type>(seed));
+    } else {
+      engines.emplace_back(static_cast<seed_type>(seed + k));
+    }
+  }
+
+  // producers fill block `block` of the output with their own engine
+  auto fill = [&](std::size_t k, std::size_t block, slot &s) {
+    if constexpr (counter_based<RNG>) {
+      seek(engines[k], static_cast<unsigned long long>(block) * words);
+    }
+    s.size = fill_block<w>(engines[k], Draw{}, s.data.get(), words);
+  };
+
+  std::vector<slot> slots(opt.threads * slots_per_producer);
+  for (auto &s : slots) {
+    s.data = make_aligned_buffer(block_capacity);
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> producers;
+  if (opt.threads > 1) {
+    for (std::size_t k = 0; k < opt.threads; ++k) {
+      producers.emplace_back([&, k]() {
+        for (std::size_t round = 0;; ++round) {
+          slot &s = slots[k * slots_per_producer + round % slots_per_producer];
+          s.full.wait(true);
+          if (stop.load()) {
+            return;
+          }
+          fill(k, round * opt.threads + k, s);
+          s.full.store(true);
+          s.full.notify_all();
+        }
+      });
+    }
+  }
+
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const auto report_interval = std::chrono::seconds(opt.report_seconds);
+  auto next_report = start + report_interval;
+  unsigned long long written = 0;
+  bool ok = true;
+  int write_error = 0;
+  for (std::size_t block = 0; ok && !interrupted.load() &&
+                              (opt.bytes == 0 || written < opt.bytes);
+       ++block) {
+    const std::size_t k = block % opt.threads;
+    const std::size_t round = block / opt.threads;
+    slot &s = slots[k * slots_per_producer + round % slots_per_producer];
+    if (opt.threads > 1) {
+      s.full.wait(false);
+    } else {
+      fill(0, block, s);
+    }
+
+    std::size_t size = s.size;
+    if (opt.bytes != 0 && opt.bytes - written < size) {
+      size = static_cast<std::size_t>(opt.bytes - written);
+    }
+    errno = 0;
+    ok = write_all(file, s.data.get(), size);
+    if (ok) {
+      written += size;
+    } else {
+      write_error = errno;
+    }
+
+    if (opt.threads > 1) {
+      s.full.store(false);
+      s.full.notify_all();
+    }
+
+    if (opt.report_seconds != 0) {
+      const auto now = clock::now();
+      if (now >= next_report) {
+        report(opt, "running", written,
+               std::chrono::duration<double>(now - start).count());
+        next_report = now + report_interval;
+      }
+    }
+  }
+  const auto stop_time = clock::now();
+
+  stop.store(true);
+  for (auto &s : slots) {
+    s.full.store(false);
+    s.full.notify_all();
+  }
+  for (auto &t : producers) {
+    t.join();
+  }
+
+  const bool stopped = interrupted.load();
+  report(opt, stopped ? "interrupted" : "done", written,
+         std::chrono::duration<double>(stop_time - start).count());
+  if (stopped) {
+    // an unbounded run is meant to be stopped, a bounded one is now truncated
+    return opt.bytes == 0 ? 0 : 1;
+  }
+  if (ok) {
+    return 0;
+  }
+  // a battery closing the pipe is how an unbounded run ends, any other error
+  // (ENOSPC, EIO, ...) means the output is truncated
+  if (opt.bytes == 0 && write_error == EPIPE) {
+    return 0;
+  }
+  std::fprintf(stderr, "random_stream: write failed: %s\n",
+               std::strerror(write_error));
+  return 1;
+}
+
+// the std and stdfix engines only have one forward draw
+struct draw {
+  template <class RNG> auto operator()(RNG &rng) const { return rng(); }
+};
+
+// philox operator() defaults to the fixed version, so both modes are spelled
+// out: Version 0 follows the std strictly, Version 1 is the fix
+template <bool Fix> struct philox_draw {
+  template <class RNG> auto operator()(RNG &rng) const {
+    return rng.template operator()<Fix ? 1 : 0>();
+  }
+};
+
+using engine_runner = int (*)(options const &, std::FILE *);
+
+struct engine_entry {
+  std::string_view name;
+  engine_runner runner;
+};
+
+template <class RNG, class Draw = draw>
+constexpr engine_runner runner_for = &run<RNG, RNG::word_size, Draw>;
+
+// to stream another parametrisation, add its instantiation here
+constexpr engine_entry engines[] = {
+    {"ranlux24_base_std", runner_for<std::ranlux24_base>},
+    {"ranlux48_base_std", runner_for<std::ranlux48_base>},
+    {"ranlux24_base_fix", runner_for<stdfix::ranlux24_base>},
+    {"ranlux48_base_fix", runner_for<stdfix::ranlux48_base>},
+    {"ranlux24_base_original",
+     runner_for<stdfix::subtract_with_carry_engine<std::uint_fast32_t, 24, 10,
+                                                   24, true>>},
+    {"ranlux48_base_original",
+     runner_for<stdfix::subtract_with_carry_engine<std::uint_fast64_t, 48, 5,
+                                                   12, true>>},
+    {"swc16_2_4_std",
+     runner_for<std::subtract_with_carry_engine<std::uint_fast32_t, 16, 2, 4>>},
+    {"swc16_2_4_fix",
+     runner_for<stdfix::subtract_with_carry_engine<std::uint_fast32_t, 16, 2,
+                                                   4>>},
+    // w not a multiple of 8, streamed through the bit packing path
+    {"swc12_5_12_fix",
+     runner_for<stdfix::subtract_with_carry_engine<std::uint_fast32_t, 12, 5,
+                                                   12>>},
+    {"philox4x32_std", runner_for<stdmock::philox4x32, philox_draw<false>>},
+    {"philox4x64_std", runner_for<stdmock::philox4x64, philox_draw<false>>},
+    {"philox4x32_fix", runner_for<stdmock::philox4x32, philox_draw<true>>},
+    {"philox4x64_fix", runner_for<stdmock::philox4x64, philox_draw<true>>},
+    {"philox4x32_7_fix",
+     runner_for<stdmock::philox4x32_7, philox_draw<true>>},
+    {"philox4x64_7_fix",
+     runner_for<stdmock::philox4x64_7, philox_draw<true>>},
+    {"philox2x64_fix", runner_for<stdmock::philox2x64, philox_draw<true>>},
+};
+
+// a plain decimal number: no sign, no spaces, no suffix
+auto parse_count(std::string_view text, unsigned long long &value) -> bool {
+  if (text.empty() || text.front() < '0' || text.front() > '9') {
+    return false;
+  }
+  const std::string digits(text);
+  char *end = nullptr;
+  errno = 0;
+  value = std::strtoull(digits.c_str(), &end, 10);
+  return errno != ERANGE && *end == '\0';
+}
+
+// a count of bytes with an optional binary K, M, G or T suffix
+auto parse_size(std::string_view text, unsigned long long &value) -> bool {
+  if (text.empty()) {
+    return false;
+  }
+  unsigned long long scale = 1;
+  switch (text.back()) {
+  case 'T':
+    scale <<= 10U;
+    [[fallthrough]];
+  case 'G':
+    scale <<= 10U;
+    [[fallthrough]];
+  case 'M':
+    scale <<= 10U;
+    [[fallthrough]];
+  case 'K':
+    scale <<= 10U;
+    text.remove_suffix(1);
+    break;
+  default:
+    break;
+  }
+  if (!parse_count(text, value) ||
+      value > std::numeric_limits<unsigned long long>::max() / scale) {
+    return false;
+  }
+  value *= scale;
+  return true;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "usage: random_stream [--engine] NAME [--bytes N[K|M|G|T]] "
+               "[--threads T]\n"
+               "                     [--seed S] [--block-size N[K|M|G]] "
+               "[-o FILE]\n"
+               "                     [--report-every SECONDS] [--draws N]\n"
+               "       random_stream --list\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  options opt;
+  for (int idx = 1; idx < argc; ++idx) {
+    const std::string_view arg = argv[idx];
+    const bool has_value = idx + 1 < argc;
+    unsigned long long value = 0;
+    if (arg == "--list") {
+      for (auto const &e : engines) {
+        std::printf("%.*s\n", static_cast<int>(e.name.size()), e.name.data());
+      }
+      return 0;
+    } else if (arg == "--engine" && has_value) {
+      opt.engine = argv[++idx];
+    } else if (arg == "--bytes" && has_value &&
+               parse_size(argv[++idx], value)) {
+      opt.bytes = value;
+    } else if (arg == "--threads" && has_value &&
+               parse_count(argv[++idx], value) && value > 0) {
+      opt.threads = static_cast<std::size_t>(value);
+    } else if (arg == "--seed" && has_value &&
+               parse_count(argv[++idx], value)) {
+      opt.seed = value;
+      opt.seed_set = true;
+    } else if (arg == "--block-size" && has_value &&
+               parse_size(argv[++idx], value) && value > 0 &&
+               value <= (1ULL << 30U)) {
+      opt.block_bytes = static_cast<std::size_t>(value);
+    } else if (arg == "--draws" && has_value &&
+               parse_count(argv[++idx], value)) {
+      opt.draws = value;
+    } else if (arg == "--report-every" && has_value &&
+               parse_count(argv[++idx], value)) {
+      opt.report_seconds = value;
+    } else if ((arg == "-o" || arg == "--output") && has_value) {
+      opt.output = argv[++idx];
+    } else if (!arg.starts_with("-") && opt.engine.empty()) {
+      opt.engine = arg;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  engine_runner runner = nullptr;
+  for (auto const &e : engines) {
+    if (e.name == opt.engine) {
+      runner = e.runner;
+    }
+  }
+  if (runner == nullptr) {
+    usage();
+    return 2;
+  }
+
+  std::signal(SIGINT, on_interrupt);
+  std::signal(SIGTERM, on_interrupt);
+#ifdef SIGPIPE
+  // a battery closing the pipe is the normal way for an unbounded run to end
+  std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+  std::FILE *file = stdout;
+  if (!opt.output.empty()) {
+    file = std::fopen(opt.output.c_str(), "wb");
+    if (file == nullptr) {
+      std::perror(opt.output.c_str());
+      return 1;
+    }
+  }
+#ifdef _WIN32
+  else {
+    _setmode(_fileno(stdout), _O_BINARY);
+  }
+#endif
+  // blocks are already large, so let fwrite hand them straight to write()
+  std::setvbuf(file, nullptr, _IONBF, 0);
+
+  int result = runner(opt, file);
+#ifdef RNG_STATS_ENABLED
+  rng_stats::dump();
+#endif
+  if (file != stdout && std::fclose(file) != 0) {
+    std::perror(opt.output.c_str());
+    result = 1;
+  }
+  return result;
+}
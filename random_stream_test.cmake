@@ -0,0 +1,114 @@
+# checks the bytes random_stream writes, run as
+#   cmake -DRANDOM_STREAM=<exe> -DWORK_DIR=<dir> -DMODE=<mode> ...
+#         -P random_stream_test.cmake
+#
+# MODE=differ         ENGINE_A and ENGINE_B must not stream the same bytes
+# MODE=known_answer   draw number DRAW of ENGINE, with WORD_BYTES bytes per
+#                     draw, must be EXPECTED (hex, most significant first).
+#                     Small blocks make the last one partial.
+# MODE=deterministic  two runs of ENGINE with THREADS producers must match,
+#                     and match a single producer run if SAME_AS_SERIAL is set
+# MODE=unpack         unpacking the WORD_SIZE bit stream of ENGINE must give
+#                     the draws printed by --draws
+
+function(stream engine file)
+  execute_process(COMMAND ${RANDOM_STREAM} ${engine} -o ${file} ${ARGN}
+                  RESULT_VARIABLE status ERROR_QUIET)
+  if(NOT status EQUAL 0)
+    message(FATAL_ERROR "random_stream ${engine} ${ARGN} failed: ${status}")
+  endif()
+endfunction()
+
+if(MODE STREQUAL "differ")
+  foreach(engine ${ENGINE_A} ${ENGINE_B})
+    stream(${engine} ${WORK_DIR}/${engine}.bin --bytes 64)
+    file(READ ${WORK_DIR}/${engine}.bin ${engine}_bytes HEX)
+    string(LENGTH "${${engine}_bytes}" length)
+    if(NOT length EQUAL 128)
+      message(FATAL_ERROR "random_stream ${engine} wrote ${length} hex digits")
+    endif()
+  endforeach()
+  if("${${ENGINE_A}_bytes}" STREQUAL "${${ENGINE_B}_bytes}")
+    message(FATAL_ERROR "${ENGINE_A} and ${ENGINE_B} stream the same bytes")
+  endif()
+
+elseif(MODE STREQUAL "known_answer")
+  math(EXPR bytes "${DRAW} * ${WORD_BYTES}")
+  set(file ${WORK_DIR}/${ENGINE}_known_answer.bin)
+  stream(${ENGINE} ${file} --bytes ${bytes} --block-size 4K)
+  file(SIZE ${file} size)
+  if(NOT size EQUAL bytes)
+    message(FATAL_ERROR "${ENGINE}: --bytes ${bytes} wrote ${size} bytes")
+  endif()
+  math(EXPR offset "${bytes} - ${WORD_BYTES}")
+  file(READ ${file} last OFFSET ${offset} LIMIT ${WORD_BYTES} HEX)
+  # the stream is little endian
+  set(value "")
+  string(LENGTH "${last}" length)
+  while(length GREATER 0)
+    math(EXPR length "${length} - 2")
+    string(SUBSTRING "${last}" ${length} 2 byte)
+    string(APPEND value "${byte}")
+  endwhile()
+  string(TOLOWER "${EXPECTED}" expected)
+  if(NOT value STREQUAL expected)
+    message(FATAL_ERROR "${ENGINE}: draw ${DRAW} is ${value}, not ${expected}")
+  endif()
+
+elseif(MODE STREQUAL "deterministic")
+  set(runs 1 2)
+  if(SAME_AS_SERIAL)
+    list(APPEND runs serial)
+  endif()
+  set(reference "")
+  foreach(run ${runs})
+    set(threads ${THREADS})
+    if(run STREQUAL "serial")
+      set(threads 1)
+    endif()
+    set(file ${WORK_DIR}/${ENGINE}_run_${run}.bin)
+    stream(${ENGINE} ${file} --bytes 100000 --block-size 4K
+           --threads ${threads})
+    file(MD5 ${file} md5)
+    if(reference STREQUAL "")
+      set(reference ${md5})
+    elseif(NOT md5 STREQUAL reference)
+      message(FATAL_ERROR "${ENGINE}: run ${run} differs (${md5})")
+    endif()
+  endforeach()
+
+elseif(MODE STREQUAL "unpack")
+  set(draws 64)
+  math(EXPR bytes "${draws} * ${WORD_SIZE} / 8")
+  stream(${ENGINE} ${WORK_DIR}/${ENGINE}_packed.bin --bytes ${bytes})
+  stream(${ENGINE} ${WORK_DIR}/${ENGINE}_draws.txt --draws ${draws})
+  file(READ ${WORK_DIR}/${ENGINE}_packed.bin packed HEX)
+  file(STRINGS ${WORK_DIR}/${ENGINE}_draws.txt expected)
+
+  # LSB first bit stream, one byte at a time
+  math(EXPR mask "(1 << ${WORD_SIZE}) - 1")
+  set(acc 0)
+  set(bits 0)
+  set(unpacked "")
+  string(LENGTH "${packed}" length)
+  set(pos 0)
+  while(pos LESS length)
+    string(SUBSTRING "${packed}" ${pos} 2 byte)
+    math(EXPR acc "${acc} | (0x${byte} << ${bits})")
+    math(EXPR bits "${bits} + 8")
+    while(NOT bits LESS WORD_SIZE)
+      math(EXPR value "${acc} & ${mask}")
+      list(APPEND unpacked ${value})
+      math(EXPR acc "${acc} >> ${WORD_SIZE}")
+      math(EXPR bits "${bits} - ${WORD_SIZE}")
+    endwhile()
+    math(EXPR pos "${pos} + 2")
+  endwhile()
+
+  if(NOT unpacked STREQUAL expected)
+    message(FATAL_ERROR "${ENGINE}: unpacked ${unpacked}, drawn ${expected}")
+  endif()
+
+else()
+  message(FATAL_ERROR "unknown MODE '${MODE}'")
+endif()
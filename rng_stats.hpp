@@ -0,0 +1,164 @@
+#ifndef RNG_STATS
+#define RNG_STATS
+
+// Opt-in counters for the hot paths that are specific to these engines.
+//
+// RNG_STATS_ENABLED turns them on. It changes the bodies of the inline engine
+// templates, so it must be set for the whole program, never for only some of
+// its translation units: configure with -DRNG_STATS=ON, or apply it with
+// target_compile_definitions. Otherwise RNG_STATS_ADD expands to nothing and
+// the engines compile exactly as without this header.
+//
+// Counters live in a thread_local block, so incrementing them is a plain load
+// and store on memory owned by the calling thread. Blocks of threads that have
+// exited are folded into a global total, so totals() covers every thread.
+
+#ifdef RNG_STATS_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace rng_stats {
+
+enum class counter : std::size_t {
+  // stdfix::subtract_with_carry_engine
+  swc_backward_draws,    // calls to operator()<false>
+  swc_carry_scans,       // backward draws that enter the carry recovery scan
+  swc_carry_scan_steps,  // iterations of that scan
+  swc_init_draws,        // draws consumed by init() canonicalization
+  swc_discard_draws,     // draws consumed by discard
+  // stdmock::philox_engine
+  philox_blocks,         // generate<Fix>() block computations
+  philox_buffered,       // values returned from the Y buffer
+  philox_discard_draws,  // draws consumed by discard
+  count
+};
+
+inline constexpr char const *counter_names[] = {
+    "swc_backward_draws", "swc_carry_scans",   "swc_carry_scan_steps",
+    "swc_init_draws",     "swc_discard_draws", "philox_blocks",
+    "philox_buffered",    "philox_discard_draws"};
+
+static_assert(std::size(counter_names) ==
+              static_cast<std::size_t>(counter::count));
+
+struct snapshot {
+  std::uint64_t values[static_cast<std::size_t>(counter::count)]{};
+
+  auto operator[](counter c) const -> std::uint64_t {
+    return values[static_cast<std::size_t>(c)];
+  }
+};
+
+namespace detail {
+
+struct thread_block;
+
+struct registry {
+  std::mutex mutex;
+  std::vector<thread_block const *> live;
+  snapshot retired;
+
+  static auto instance() -> registry & {
+    static registry r;
+    return r;
+  }
+};
+
+struct thread_block {
+  std::atomic<std::uint64_t> values[static_cast<std::size_t>(counter::count)]{};
+
+  thread_block() {
+    registry &r = registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(this);
+  }
+
+  ~thread_block() {
+    registry &r = registry::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (std::size_t c = 0; c < static_cast<std::size_t>(counter::count); ++c) {
+      r.retired.values[c] += values[c].load(std::memory_order_relaxed);
+    }
+    r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+  }
+
+  // only the owning thread writes, so no read-modify-write is needed
+  inline void add(counter c, std::uint64_t n) {
+    auto &v = values[static_cast<std::size_t>(c)];
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  auto read() const -> snapshot {
+    snapshot s;
+    for (std::size_t c = 0; c < static_cast<std::size_t>(counter::count); ++c) {
+      s.values[c] = values[c].load(std::memory_order_relaxed);
+    }
+    return s;
+  }
+};
+
+inline auto local() -> thread_block & {
+  thread_local thread_block block;
+  return block;
+}
+
+} // namespace detail
+
+inline void add(counter c, std::uint64_t n) { detail::local().add(c, n); }
+
+// counters of the calling thread
+inline auto thread_totals() -> snapshot { return detail::local().read(); }
+
+// counters of every thread, running or exited
+inline auto totals() -> snapshot {
+  detail::registry &r = detail::registry::instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  snapshot s = r.retired;
+  for (auto const *block : r.live) {
+    const snapshot b = block->read();
+    for (std::size_t c = 0; c < static_cast<std::size_t>(counter::count); ++c) {
+      s.values[c] += b.values[c];
+    }
+  }
+  return s;
+}
+
+// zeroes the counters of the calling thread
+inline void reset() {
+  detail::thread_block &b = detail::local();
+  for (auto &v : b.values) {
+    v.store(0, std::memory_order_relaxed);
+  }
+}
+
+inline void dump(std::FILE *out = stderr) {
+  const snapshot local = thread_totals();
+  const snapshot all = totals();
+  std::fprintf(out, "%-22s %20s %20s\n", "counter", "this thread",
+               "all threads");
+  for (std::size_t c = 0; c < static_cast<std::size_t>(counter::count); ++c) {
+    std::fprintf(out, "%-22s %20llu %20llu\n", counter_names[c],
+                 static_cast<unsigned long long>(local.values[c]),
+                 static_cast<unsigned long long>(all.values[c]));
+  }
+}
+
+} // namespace rng_stats
+
+#define RNG_STATS_ADD(name, n)                                                 \
+  ::rng_stats::add(::rng_stats::counter::name,                                 \
+                   static_cast<std::uint64_t>(n))
+
+#else
+
+#define RNG_STATS_ADD(name, n) static_cast<void>(0)
+
+#endif // RNG_STATS_ENABLED
+
+#endif // RNG_STATS
@@ -0,0 +1,109 @@
+#include "philox_engine.hpp"
+#include "subtract_with_carry_engine.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#ifndef RNG_STATS_ENABLED
+#error "rng_stats_test must be built with RNG_STATS_ENABLED"
+#endif
+
+namespace {
+
+int result = 0;
+
+// unlike assert, still checks in Release builds
+void check(bool ok, char const *what) {
+  if (!ok) {
+    std::fprintf(stderr, "rng_stats_test: failed: %s\n", what);
+    result = 1;
+  }
+}
+
+} // namespace
+
+int main() {
+  using rng_stats::counter;
+
+  // subtract with carry: init canonicalization, discard and backward draws
+  {
+    rng_stats::reset();
+    stdfix::ranlux24_base rng;
+    auto stats = rng_stats::thread_totals();
+    check(stats[counter::swc_init_draws] ==
+              2 * stdfix::ranlux24_base::long_lag,
+          "init draws are counted");
+    // canonicalization walks backwards but is not a production draw
+    check(stats[counter::swc_backward_draws] == 0, "init is not a draw");
+    check(stats[counter::swc_carry_scans] == 0, "init scans not counted");
+
+    rng.discard(100);
+    check(rng_stats::thread_totals()[counter::swc_discard_draws] == 100,
+          "discard draws are counted");
+
+    for (std::size_t i = 0; i < 100; ++i) {
+      rng.operator()<false>();
+    }
+    stats = rng_stats::thread_totals();
+    check(stats[counter::swc_backward_draws] == 100,
+          "backward draws are counted");
+    // the scan is only skipped when the recovered difference is exactly 0 or
+    // 2^w, and it stops at its first step unless the previous difference is 0
+    // as well. Neither happens on these 100 draws of a 24 bit engine, so every
+    // draw reaches the else branch and scans exactly once.
+    check(stats[counter::swc_carry_scans] == 100,
+          "every backward draw here enters the carry scan");
+    check(stats[counter::swc_carry_scan_steps] == 100,
+          "every scan here stops after one step");
+    check(stats[counter::swc_carry_scan_steps] >=
+                  stats[counter::swc_carry_scans] &&
+              stats[counter::swc_carry_scan_steps] > 0,
+          "every scan takes a step");
+
+    // the original engine skips canonicalization
+    rng_stats::reset();
+    stdfix::subtract_with_carry_engine<std::uint_fast32_t, 24, 10, 24, true>
+        rng_original;
+    check(rng_stats::thread_totals()[counter::swc_init_draws] == 0,
+          "original engine does not canonicalize");
+    rng_original();
+  }
+
+  // philox: one block every n draws, the rest comes from the buffer
+  {
+    rng_stats::reset();
+    stdmock::philox4x32 rng;
+    for (std::size_t i = 0; i < 10; ++i) {
+      rng();
+    }
+    check(rng_stats::thread_totals()[counter::philox_blocks] == 3,
+          "one block per n draws");
+    check(rng_stats::thread_totals()[counter::philox_buffered] == 7,
+          "other draws are buffered");
+
+    rng.discard<true>(6);
+    check(rng_stats::thread_totals()[counter::philox_discard_draws] == 6,
+          "discard draws are counted");
+    check(rng_stats::thread_totals()[counter::philox_blocks] == 4,
+          "discard computes blocks");
+  }
+
+  // counters are per thread, totals include exited threads
+  {
+    const auto before = rng_stats::totals()[counter::philox_blocks];
+    std::uint64_t worker_blocks = 0;
+    std::thread worker([&worker_blocks]() {
+      stdmock::philox4x64 rng;
+      rng.discard(8);
+      worker_blocks = rng_stats::thread_totals()[counter::philox_blocks];
+    });
+    worker.join();
+    check(worker_blocks == 2, "counters are per thread");
+    check(rng_stats::totals()[counter::philox_blocks] == before + 2,
+          "totals include exited threads");
+    rng_stats::dump();
+  }
+
+  return result;
+}
@@ -0,0 +1,132 @@
+#include "philox_engine.hpp"
+#include "philox_stream_broker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Contention benchmark for handing random numbers to many short lived tasks.
+//
+//   stream_broker_bench [max_threads] [tasks_per_thread] [draws_per_task]
+//
+// For 1, 2, 4, ... max_threads threads, every thread runs its share of tasks
+// with each of the following strategies:
+//   seed_seq : every task builds its own philox4x64 from a std::seed_seq
+//   mutex    : every draw locks a single shared philox4x64
+//   lease    : every task leases the next substream of a stream_broker
+//   keyed    : every task takes the substream keyed by its task id
+
+namespace {
+
+using engine = stdmock::philox4x64;
+
+std::atomic<std::uint64_t> sink{0};
+
+template <class Task>
+auto run(std::size_t threads, std::size_t tasks_per_thread, Task task)
+    -> double {
+  std::vector<std::thread> workers;
+  std::atomic<bool> go{false};
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      std::uint64_t acc = 0;
+      for (std::size_t i = 0; i < tasks_per_thread; ++i) {
+        acc += task(t * tasks_per_thread + i);
+      }
+      sink.fetch_add(acc);
+    });
+  }
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true);
+  for (auto &w : workers) {
+    w.join();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void report(char const *name, std::size_t threads, std::size_t tasks,
+            std::size_t draws, double seconds) {
+  std::printf("%-9s %7zu %14.3f %12.2f\n", name, threads,
+              static_cast<double>(tasks) / seconds / 1e6,
+              seconds * 1e9 / static_cast<double>(tasks * draws));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const std::size_t hardware =
+      std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  const std::size_t max_threads =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : hardware;
+  const std::size_t tasks_per_thread =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+  const std::size_t draws =
+      argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 4096;
+
+  std::printf("%-9s %7s %14s %12s\n", "strategy", "threads", "Mtasks/s",
+              "ns/draw");
+
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    const std::size_t tasks = threads * tasks_per_thread;
+
+    report("seed_seq", threads, tasks, draws,
+           run(threads, tasks_per_thread, [&](std::size_t id) {
+             std::seed_seq seq{static_cast<std::uint32_t>(id),
+                               static_cast<std::uint32_t>(id >> 32U)};
+             engine rng(seq);
+             std::uint64_t acc = 0;
+             for (std::size_t d = 0; d < draws; ++d) {
+               acc += rng.operator()<true>();
+             }
+             return acc;
+           }));
+
+    engine shared;
+    std::mutex mutex;
+    report("mutex", threads, tasks, draws,
+           run(threads, tasks_per_thread, [&](std::size_t) {
+             std::uint64_t acc = 0;
+             for (std::size_t d = 0; d < draws; ++d) {
+               std::lock_guard<std::mutex> lock(mutex);
+               acc += shared.operator()<true>();
+             }
+             return acc;
+           }));
+
+    stdmock::stream_broker<engine> leasing;
+    report("lease", threads, tasks, draws,
+           run(threads, tasks_per_thread, [&](std::size_t) {
+             engine rng = leasing.lease();
+             std::uint64_t acc = 0;
+             for (std::size_t d = 0; d < draws; ++d) {
+               acc += rng.operator()<true>();
+             }
+             return acc;
+           }));
+
+    stdmock::stream_broker<engine> keyed;
+    report("keyed", threads, tasks, draws,
+           run(threads, tasks_per_thread, [&](std::size_t id) {
+             engine rng = keyed.stream(id);
+             std::uint64_t acc = 0;
+             for (std::size_t d = 0; d < draws; ++d) {
+               acc += rng.operator()<true>();
+             }
+             return acc;
+           }));
+  }
+
+  return 0;
+}
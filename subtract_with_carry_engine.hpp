@@ -1,6 +1,8 @@
 #ifndef SUBTRACT_WITH_CARRY_ENGINE
 #define SUBTRACT_WITH_CARRY_ENGINE
 
+#include "rng_stats.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cmath>
@@ -42,11 +44,12 @@ private:
 
     this->carry = (this->x[long_lag - 1] == 0);
     if constexpr (!original) {
+      RNG_STATS_ADD(swc_init_draws, 2 * long_lag);
       for (std::size_t j = 0; j < long_lag; ++j) {
-        this->operator()();
+        this->step<true, false>();
       }
       for (std::size_t j = 0; j < long_lag; ++j) {
-        this->operator()<false>();
+        this->step<false, false>();
       }
     }
   }
@@ -84,6 +87,19 @@ public:
   }
 
   template <bool FwdDirection = true> inline auto operator()() -> result_type {
+    return this->step<FwdDirection, true>();
+  }
+
+  void discard(unsigned long long z) {
+    RNG_STATS_ADD(swc_discard_draws, z);
+    for (unsigned long long j = 0; j < z; ++j) {
+      this->operator()();
+    }
+  }
+
+private:
+  // Counted = false keeps init() canonicalization out of the draw counters
+  template <bool FwdDirection, bool Counted> inline auto step() -> result_type {
 
     if constexpr (FwdDirection) {
       const std::size_t short_index = (this->i < short_lag)
@@ -105,6 +121,9 @@ public:
       this->i = (this->i == (long_lag - 1)) ? 0 : (this->i + 1);
       return result;
     } else {
+      if constexpr (Counted) {
+        RNG_STATS_ADD(swc_backward_draws, 1);
+      }
       this->i = (this->i == 0) ? (long_lag - 1) : (this->i - 1);
       const UIntType result = this->x[this->i];
 
@@ -124,7 +143,13 @@ public:
         std::size_t k_prev = this->i;
         UIntType temp_prev = 0;
         std::size_t short_index_prev = short_index;
+        if constexpr (Counted) {
+          RNG_STATS_ADD(swc_carry_scans, 1);
+        }
         do {
+          if constexpr (Counted) {
+            RNG_STATS_ADD(swc_carry_scan_steps, 1);
+          }
           k_prev = (k_prev == 0) ? (long_lag - 1) : (k_prev - 1);
           short_index_prev = (k_prev < short_lag)
                                  ? (k_prev + long_lag - short_lag)
@@ -150,12 +175,7 @@ public:
     }
   }
 
-  void discard(unsigned long long z) {
-    for (unsigned long long j = 0; j < z; ++j) {
-      this->operator()();
-    }
-  }
-
+public:
   static constexpr auto min() -> UIntType {
     return static_cast<result_type>(0U);
   }